@@ -0,0 +1,34 @@
+#ifndef ARTIFACT_STORE_HPP
+#define ARTIFACT_STORE_HPP
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "configparse.h"
+
+// Host-wide store of finished dependency builds, keyed by a Merkle hash of
+// the project's config, build recipe, sources, headers, toolchain and dependency hashes.
+// Each entry also records every file the compiler read, which is re-checked on lookup.
+class ArtifactStore {
+public:
+    static std::filesystem::path root();
+    static std::string hashProject(const std::filesystem::path& projectPath, const ConfigParse::Config& config,
+                                   int recipeVersion, const std::string& toolchain,
+                                   const std::vector<std::string>& dependencyHashes);
+    static std::optional<std::filesystem::path> lookup(const std::string& hash, const std::string& output,
+                                                       const std::filesystem::path& projectPath);
+    static std::optional<std::filesystem::path> store(const std::string& hash, const std::filesystem::path& outputDir,
+                                                      const std::string& output,
+                                                      const std::filesystem::path& projectPath,
+                                                      const std::vector<std::string>& usedInputs);
+
+private:
+    static bool isComplete(const std::filesystem::path& entry, const std::string& output,
+                           const std::filesystem::path& projectPath);
+    static std::vector<std::filesystem::path> collectInputs(const std::filesystem::path& projectPath,
+                                                            const ConfigParse::Config& config);
+};
+
+#endif // ARTIFACT_STORE_HPP
@@ -5,6 +5,9 @@
 
 class BuildSystem {
 public:
+    // Part of every artifact store key; bump whenever generateNinjaFile changes how objects are built.
+    static constexpr int ninjaRecipeVersion = 1;
+
     static void build(const ConfigParse::Config& config);
     static std::string executeCommand(const std::string& command);
     static void addPkgConfigFlags(const ConfigParse::Config& config, std::string& build_cmd);
@@ -16,6 +19,9 @@ private:
     static void addDependencyLibrariesString(const ConfigParse::Config& config, std::string& ldflags);
     static void buildDependency(const std::string& dependencyPath);
     static std::string getDependencyLibraryPath(const std::string& dependencyPath);
+    static std::string findCompiler(const std::vector<std::string>& compilers);
+    static std::string hashDependency(const std::string& dependencyPath);
+    static std::vector<std::string> getUsedInputs();
 };
 
 #endif // BUILD_SYSTEM_HPP
@@ -0,0 +1,17 @@
+#ifndef SHA256_HPP
+#define SHA256_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class Sha256 {
+public:
+    static std::string hex(std::string_view data);
+
+private:
+    static void transform(std::array<std::uint32_t, 8>& state, const unsigned char* block);
+};
+
+#endif // SHA256_HPP
@@ -0,0 +1,222 @@
+#include "artifact_store.hpp"
+#include "logger.hpp"
+#include "sha256.hpp"
+#include "sys.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+    const std::string manifestName = "velux-artifact.manifest";
+
+    const std::set<std::string> hashedExtensions = {
+        ".c", ".cc", ".cpp", ".cxx", ".c++", ".h", ".hh", ".hpp", ".hxx", ".h++", ".inl", ".ipp", ".tpp"
+    };
+
+    bool isSkippedDirectory(const std::filesystem::path& dir) {
+        const std::string name = dir.filename().string();
+        return name == "velux-out" || (!name.empty() && name.front() == '.');
+    }
+
+    void collectHeaders(const std::filesystem::path& dir, std::set<std::filesystem::path>& files) {
+        std::error_code ec;
+        if(!std::filesystem::is_directory(dir, ec))
+            return;
+
+        for(auto it = std::filesystem::recursive_directory_iterator(dir, ec);
+            it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if(ec)
+                break;
+
+            if(it->is_directory(ec)) {
+                if(isSkippedDirectory(it->path()))
+                    it.disable_recursion_pending();
+                continue;
+            }
+
+            if(it->is_regular_file(ec) && hashedExtensions.contains(it->path().extension().string()))
+                files.insert(it->path().lexically_normal());
+        }
+    }
+}
+
+std::filesystem::path ArtifactStore::root() {
+    if(const char* custom = std::getenv("VELUX_ARTIFACT_STORE"); custom && *custom)
+        return custom;
+
+    if(const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+        return std::filesystem::path(xdg) / "velux" / "artifacts";
+
+    if(const char* home = std::getenv("HOME"); home && *home)
+        return std::filesystem::path(home) / ".cache" / "velux" / "artifacts";
+
+    return std::filesystem::temp_directory_path() / "velux" / "artifacts";
+}
+
+std::string ArtifactStore::hashProject(const std::filesystem::path& projectPath, const ConfigParse::Config& config,
+                                       const int recipeVersion, const std::string& toolchain,
+                                       const std::vector<std::string>& dependencyHashes) {
+    // Every input becomes a leaf hash; the project hash is the hash over all leaves.
+    std::string leaves;
+
+    leaves += "config " + Sha256::hex(Sys::read_to_string(projectPath / "velux.json")) + "\n";
+    leaves += "recipe " + std::to_string(recipeVersion) + "\n";
+
+    // Debug info embeds the build directory, so debug builds are only shared within one checkout.
+    const bool debug = std::ranges::any_of(config.flags, [](const std::string& flag) {
+        return flag.starts_with("-g") && flag != "-g0";
+    });
+    if(debug)
+        leaves += "checkout " + projectPath.string() + "\n";
+    leaves += "toolchain " + Sha256::hex(toolchain) + "\n";
+
+    for(const std::filesystem::path& file : collectInputs(projectPath, config)) {
+        if(!std::filesystem::exists(file))
+            throw std::runtime_error("Missing input file: " + file.string());
+
+        const std::string relative = file.lexically_relative(projectPath).generic_string();
+        leaves += "file " + relative + " " + Sha256::hex(Sys::read_to_string(file)) + "\n";
+    }
+
+    for(const std::string& dependencyHash : dependencyHashes) {
+        leaves += "dependency " + dependencyHash + "\n";
+    }
+
+    return Sha256::hex(leaves);
+}
+
+std::optional<std::filesystem::path> ArtifactStore::lookup(const std::string& hash, const std::string& output,
+                                                           const std::filesystem::path& projectPath) {
+    const std::filesystem::path entry = root() / hash;
+    if(!isComplete(entry, output, projectPath))
+        return std::nullopt;
+
+    // Refresh the entry's mtime so age-based pruning only removes artifacts nobody links anymore.
+    std::error_code ec;
+    std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), ec);
+
+    return entry / output;
+}
+
+std::optional<std::filesystem::path> ArtifactStore::store(const std::string& hash, const std::filesystem::path& outputDir,
+                                                          const std::string& output,
+                                                          const std::filesystem::path& projectPath,
+                                                          const std::vector<std::string>& usedInputs) {
+    const std::filesystem::path destination = root() / hash;
+    const std::filesystem::path staging = root() / (hash + ".tmp-" + std::to_string(getpid()));
+
+    if(isComplete(destination, output, projectPath))
+        return destination / output;
+
+    // Copy into a private staging directory first so concurrent builds never see a partial artifact.
+    std::error_code ec;
+    std::filesystem::remove_all(staging, ec);
+    std::filesystem::create_directories(staging, ec);
+    if(!ec)
+        std::filesystem::copy(outputDir, staging, std::filesystem::copy_options::recursive, ec);
+
+    if(!ec && !std::filesystem::is_regular_file(staging / output, ec))
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+
+    if(!ec) {
+        std::ofstream manifest(staging / manifestName);
+        manifest << "artifact " << Sha256::hex(Sys::read_to_string(staging / output)) << " " << output << "\n";
+
+        // Relative inputs are recorded as-is and resolved against whichever checkout looks the entry up.
+        // An input that vanished since the build cannot be verified later, so the entry is not stored at all.
+        for(const std::string& input : usedInputs) {
+            std::error_code inputEc;
+            const std::filesystem::path file = projectPath / input;
+            if(!std::filesystem::is_regular_file(file, inputEc)) {
+                Logger::warning("Not storing artifact " + hash + ": input disappeared: " + input, "Artifact-Store");
+                manifest.close();
+                std::filesystem::remove_all(staging, inputEc);
+                return std::nullopt;
+            }
+
+            manifest << "input " << Sha256::hex(Sys::read_to_string(file)) << " " << input << "\n";
+        }
+
+        if(!manifest)
+            ec = std::make_error_code(std::errc::io_error);
+    }
+
+    // Another build may have completed the entry while this one was staging; keep theirs if so.
+    if(!ec && isComplete(destination, output, projectPath)) {
+        std::filesystem::remove_all(staging, ec);
+        return destination / output;
+    }
+
+    // A leftover entry without a valid artifact is moved aside, not deleted in place, then replaced.
+    if(!ec) {
+        const std::filesystem::path stale = root() / (hash + ".old-" + std::to_string(getpid()));
+        std::error_code ignored;
+        std::filesystem::remove_all(stale, ignored);
+        std::filesystem::rename(destination, stale, ignored);
+        std::filesystem::rename(staging, destination, ec);
+        std::filesystem::remove_all(stale, ignored);
+    }
+
+    if(ec) {
+        std::error_code ignored;
+        std::filesystem::remove_all(staging, ignored);
+
+        if(isComplete(destination, output, projectPath))
+            return destination / output;
+
+        Logger::warning("Could not store artifact " + hash + ": " + ec.message(), "Artifact-Store");
+        return std::nullopt;
+    }
+
+    return destination / output;
+}
+
+bool ArtifactStore::isComplete(const std::filesystem::path& entry, const std::string& output,
+                               const std::filesystem::path& projectPath) {
+    std::error_code ec;
+    const std::filesystem::path manifestPath = entry / manifestName;
+    const std::filesystem::path artifact = entry / output;
+    if(!std::filesystem::is_regular_file(manifestPath, ec) || !std::filesystem::is_regular_file(artifact, ec))
+        return false;
+
+    std::istringstream manifest(Sys::read_to_string(manifestPath));
+    std::string kind, digest, name;
+    if(!(manifest >> kind >> digest) || kind != "artifact" || !std::getline(manifest >> std::ws, name) || name != output)
+        return false;
+
+    if(digest != Sha256::hex(Sys::read_to_string(artifact)))
+        return false;
+
+    // Any header the compiler read, including system and package headers, must still match.
+    while(manifest >> kind >> digest && std::getline(manifest >> std::ws, name)) {
+        const std::filesystem::path file = projectPath / name;
+        if(kind != "input" || !std::filesystem::is_regular_file(file, ec) ||
+           digest != Sha256::hex(Sys::read_to_string(file)))
+            return false;
+    }
+
+    return true;
+}
+
+std::vector<std::filesystem::path> ArtifactStore::collectInputs(const std::filesystem::path& projectPath,
+                                                                const ConfigParse::Config& config) {
+    std::set<std::filesystem::path> files;
+
+    for(const std::string& src : config.sources) {
+        files.insert((projectPath / src).lexically_normal());
+    }
+
+    collectHeaders(projectPath, files);
+
+    // Headers under absolute include paths, -I flags and packages are checked through the entry's recorded inputs.
+    for(const std::string& inc : config.include) {
+        if(std::filesystem::path(inc).is_relative())
+            collectHeaders((projectPath / inc).lexically_normal(), files);
+    }
+
+    return {files.begin(), files.end()};
+}
@@ -1,4 +1,5 @@
 #include "build_system.hpp"
+#include "artifact_store.hpp"
 #include "configparse.h"
 #include "logger.hpp"
 #include "sys.hpp"
@@ -6,7 +7,22 @@
 #include <cstdio>
 #include <memory>
 #include <fstream>
+#include <set>
 #include <sstream>
+#include <unordered_map>
+
+namespace {
+    // Keyed by canonical dependency path, valid for the lifetime of one velux invocation.
+    std::unordered_map<std::string, std::string> dependencyHashes;
+    std::unordered_map<std::string, std::string> storedLibraries;
+    std::unordered_map<std::string, bool> compilerProbes;
+
+    std::string canonicalKey(const std::string& path) {
+        std::error_code ec;
+        const std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+        return ec ? std::filesystem::absolute(path).lexically_normal().string() : canonical.string();
+    }
+}
 
 void BuildSystem::build(const ConfigParse::Config& config) {
     Logger::info("Parsing config...", "Builder");
@@ -21,21 +37,8 @@ void BuildSystem::build(const ConfigParse::Config& config) {
         }
     }
 
-    const std::string target = config.output;
-    const std::vector<std::string> compilers = config.compilers;
-    const std::vector<std::string> sources = config.sources;
-    const std::vector<std::string> flags = config.flags;
-    const std::string language = config.language;
-
-    std::string compiler;
-
     Logger::info("Finding Compiler...", "Builder");
-    for(const std::string& c : compilers) {
-        if(Sys::safe_system(c, true)) {
-            compiler = c;
-            break;
-        }
-    }
+    const std::string compiler = findCompiler(config.compilers);
 
     if(compiler.empty()) {
         Logger::error("Could not find suitable compiler!", "Builder");
@@ -91,7 +94,7 @@ void BuildSystem::generateNinjaFile(const ConfigParse::Config& config, const std
 
     if(config.type == "library") {
         ninja_file << "rule cc\n";
-        ninja_file << "  command = $cc $cflags -c $in -o $out\n";
+        ninja_file << "  command = $cc $cflags -MD -MF $out.d -c $in -o $out\n";
         ninja_file << "  depfile = $out.d\n";
         ninja_file << "  deps = gcc\n\n";
 
@@ -118,7 +121,7 @@ void BuildSystem::generateNinjaFile(const ConfigParse::Config& config, const std
         ninja_file << "default " << output_path << "\n";
     } else {
         ninja_file << "rule cc\n";
-        ninja_file << "  command = $cc $cflags -c $in -o $out\n";
+        ninja_file << "  command = $cc $cflags -MD -MF $out.d -c $in -o $out\n";
         ninja_file << "  depfile = $out.d\n";
         ninja_file << "  deps = gcc\n\n";
 
@@ -247,14 +250,38 @@ void BuildSystem::buildDependency(const std::string& dependencyPath) {
 
     try {
         const ConfigParse::Config depConfig = ConfigParse::parseConfigFromFile(configPath);
+        const std::string hash = hashDependency(dependencyPath);
+
+        if(!hash.empty()) {
+            if(const auto artifact = ArtifactStore::lookup(hash, depConfig.output, dependencyPath)) {
+                storedLibraries[canonicalKey(dependencyPath)] = artifact->string();
+                Logger::info("Using stored artifact " + hash + " for dependency: " + dependencyPath,
+                             "Builder-Dependency");
+                return;
+            }
+        }
+
         const std::string originalDir = std::filesystem::current_path();
 
         std::filesystem::current_path(dependencyPath);
 
         build(depConfig);
+        const std::vector<std::string> usedInputs = hash.empty() ? std::vector<std::string>() : getUsedInputs();
 
         std::filesystem::current_path(originalDir);
 
+        // Link the stored copy right away so the parent's link line matches later cache hits.
+        const std::filesystem::path outputDir = std::filesystem::path(dependencyPath) / "velux-out";
+        std::optional<std::filesystem::path> artifact;
+        if(!hash.empty()) {
+            artifact = ArtifactStore::store(hash, outputDir, depConfig.output, dependencyPath, usedInputs);
+        }
+
+        if(artifact) {
+            storedLibraries[canonicalKey(dependencyPath)] = artifact->string();
+            Logger::info("Stored artifact " + hash + " for dependency: " + dependencyPath, "Builder-Dependency");
+        }
+
         Logger::info("Successfully built dependency: " + dependencyPath, "Builder-Dependency");
     } catch(const std::exception& e) {
         Logger::error("Failed to build dependency " + dependencyPath + ": " + e.what(), "Builder-Dependency");
@@ -263,6 +290,10 @@ void BuildSystem::buildDependency(const std::string& dependencyPath) {
 }
 
 std::string BuildSystem::getDependencyLibraryPath(const std::string& dependencyPath) {
+    if(const auto stored = storedLibraries.find(canonicalKey(dependencyPath)); stored != storedLibraries.end()) {
+        return stored->second;
+    }
+
     const std::string configPath = dependencyPath + "/velux.json";
 
     try {
@@ -279,3 +310,82 @@ std::string BuildSystem::getDependencyLibraryPath(const std::string& dependencyP
     return "";
 }
 
+std::string BuildSystem::findCompiler(const std::vector<std::string>& compilers) {
+    for(const std::string& c : compilers) {
+        auto probe = compilerProbes.find(c);
+        if(probe == compilerProbes.end()) {
+            probe = compilerProbes.emplace(c, Sys::safe_system(c, true) != 0).first;
+        }
+
+        if(probe->second) {
+            return c;
+        }
+    }
+
+    return "";
+}
+
+std::string BuildSystem::hashDependency(const std::string& dependencyPath) {
+    const std::string key = canonicalKey(dependencyPath);
+    if(const auto cached = dependencyHashes.find(key); cached != dependencyHashes.end()) {
+        return cached->second;
+    }
+
+    // An empty hash means the dependency cannot be cached and is always built from source.
+    std::string hash;
+    try {
+        const std::filesystem::path projectPath = dependencyPath;
+        const ConfigParse::Config depConfig = ConfigParse::parseConfigFromFile((projectPath / "velux.json").string());
+
+        std::vector<std::string> childHashes;
+        for(const std::string& child : depConfig.dependencies) {
+            std::string childHash = hashDependency((projectPath / child).string());
+            if(childHash.empty()) {
+                dependencyHashes[key] = "";
+                return "";
+            }
+            childHashes.push_back(std::move(childHash));
+        }
+
+        if(const std::string compiler = findCompiler(depConfig.compilers); !compiler.empty()) {
+            std::string toolchain = compiler + "\n" + executeCommand(compiler + " --version 2>/dev/null");
+
+            // Queried directly so hashing stays silent; build() reports pkg-config problems itself.
+            if(!depConfig.find_pkg.empty()) {
+                std::string packages;
+                for(const std::string& package : depConfig.find_pkg) {
+                    packages += " " + package;
+                }
+
+                toolchain += "\n" + executeCommand("pkg-config --cflags --libs" + packages + " 2>/dev/null");
+                toolchain += "\n" + executeCommand("pkg-config --modversion" + packages + " 2>/dev/null");
+            }
+
+            hash = ArtifactStore::hashProject(key, depConfig, ninjaRecipeVersion, toolchain, childHashes);
+        }
+    } catch(const std::exception& e) {
+        Logger::warning("Could not hash dependency " + dependencyPath + ": " + e.what(), "Builder-Dependency");
+    }
+
+    dependencyHashes[key] = hash;
+    return hash;
+}
+
+std::vector<std::string> BuildSystem::getUsedInputs() {
+    // ninja keeps the compiler's depfiles in .ninja_deps; every indented line of -t deps is one input.
+    std::istringstream deps(executeCommand("ninja -t deps 2>/dev/null"));
+    std::set<std::string> inputs;
+
+    std::string line;
+    while(std::getline(deps, line)) {
+        if(line.empty() || line.front() != ' ') {
+            continue;
+        }
+
+        if(const std::size_t start = line.find_first_not_of(' '); start != std::string::npos) {
+            inputs.insert(line.substr(start));
+        }
+    }
+
+    return {inputs.begin(), inputs.end()};
+}